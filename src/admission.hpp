@@ -0,0 +1,55 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+// Per-session rate limits applied before a command reaches the order book.
+struct AdmissionLimits
+{
+    double messages_per_sec = 1000.0; // sustained rate
+    double burst = 100.0;             // bucket size, messages allowed back to back
+};
+
+// Per-session counters, reported by the STATS command.
+struct SessionStats
+{
+    uint64_t received = 0;  // commands read from the socket
+    uint64_t admitted = 0;  // commands passed on to the order book
+    uint64_t throttled = 0; // commands rejected with THROTTLED
+};
+
+// Classic token bucket: refills at `messages_per_sec`, holds at most `burst` tokens.
+class TokenBucket
+{
+    using Clock = std::chrono::steady_clock;
+
+public:
+    explicit TokenBucket(const AdmissionLimits &limits)
+        : rate_(limits.messages_per_sec),
+          burst_(limits.burst),
+          tokens_(limits.burst),
+          last_(Clock::now())
+    {
+    }
+
+    // Take one token if available. Returns false if the caller is over its limit.
+    bool try_acquire()
+    {
+        auto now = Clock::now();
+        std::chrono::duration<double> elapsed = now - last_;
+        last_ = now;
+        tokens_ = std::min(burst_, tokens_ + elapsed.count() * rate_);
+        if (tokens_ < 1.0)
+        {
+            return false;
+        }
+        tokens_ -= 1.0;
+        return true;
+    }
+
+private:
+    double rate_;
+    double burst_;
+    double tokens_;
+    Clock::time_point last_;
+};
@@ -0,0 +1,185 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include "types.hpp"
+
+// Prices on the ladder are integer multiples of kTickSize.
+constexpr double kTicksPerUnit = 100.0;
+constexpr double kTickSize = 1.0 / kTicksPerUnit;
+// Prices are accepted up to 100000.00.
+constexpr uint64_t kMaxPriceTicks = 10'000'000;
+// Size of the ladder the level index is built over, a power of two covering every tick.
+constexpr uint64_t kLadderSize = 1 << 24;
+static_assert(kLadderSize >= kMaxPriceTicks, "ladder must cover every valid tick");
+
+// Convert a price to its tick on the ladder. Returns std::nullopt if the price
+// is not finite, not a multiple of kTickSize or is outside the ladder.
+inline std::optional<uint64_t> price_to_ticks(double price)
+{
+    if (!std::isfinite(price))
+    {
+        return std::nullopt;
+    }
+    double ticks = std::round(price * kTicksPerUnit);
+    if (ticks < 0 || ticks >= static_cast<double>(kMaxPriceTicks) || std::fabs(ticks / kTicksPerUnit - price) > kTickSize * 1e-6)
+    {
+        return std::nullopt;
+    }
+    return static_cast<uint64_t>(ticks);
+}
+
+inline double ticks_to_price(uint64_t ticks)
+{
+    // dividing keeps e.g. 10010 ticks at exactly the double nearest 100.1
+    return static_cast<double>(ticks) / kTicksPerUnit;
+}
+
+// Quantity and notional sums. A level holds up to INT64_MAX and a tick is below
+// 2^24, so sums over many orders need more than 64 bits.
+__extension__ typedef unsigned __int128 LadderSum;
+
+// Result of walking one side of the book for a given quantity.
+struct WalkResult
+{
+    uint64_t qty;         // quantity that can be filled (may be less than requested)
+    LadderSum notional;   // sum of qty * price, in ticks
+    uint64_t worst_tick;  // last (worst) price level touched
+    uint64_t levels;      // number of price levels consumed
+};
+
+// Cumulative quantity / notional index over one side of the price ladder.
+// A sparse Fenwick tree over all kLadderSize ticks: only the nodes on the update
+// paths of non-empty levels are stored (at most log2(kLadderSize) per level), so
+// memory follows the number of resting levels, never the price range, and nothing
+// is rebuilt when prices move. Updates and depth walks cost O(log kLadderSize).
+// Not thread safe, the owning OrderBook guards it with its mutex.
+class LevelIndex
+{
+public:
+    explicit LevelIndex(Side side)
+        : side_(side)
+    {
+    }
+
+    // Add (or remove, with a negative delta) resting quantity at a price tick.
+    void add(uint64_t tick, int64_t delta)
+    {
+        auto [level, inserted] = level_qty_.try_emplace(tick, 0);
+        LadderSum before = level->second;
+        level->second += static_cast<LadderSum>(delta);
+        LadderSum after = level->second;
+        if (after == 0)
+        {
+            level_qty_.erase(level);
+        }
+        int64_t level_delta = (before == 0 && after > 0) ? 1 : (before > 0 && after == 0) ? -1 : 0;
+        // wraps modulo 2^128 for negative deltas, like the sums themselves
+        LadderSum qty_delta = static_cast<LadderSum>(delta);
+        LadderSum notional_delta = qty_delta * tick;
+
+        for (uint64_t i = tick + 1; i <= kLadderSize; i += i & (~i + 1))
+        {
+            auto [node, created] = nodes_.try_emplace(i);
+            node->second.qty += qty_delta;
+            node->second.notional += notional_delta;
+            node->second.levels += level_delta;
+            // an empty range also has no notional and no levels
+            if (node->second.qty == 0)
+            {
+                nodes_.erase(node);
+            }
+        }
+        total_.qty += qty_delta;
+        total_.notional += notional_delta;
+        total_.levels += level_delta;
+    }
+
+    // Resting quantity at a single tick, saturated at UINT64_MAX.
+    uint64_t level_qty(uint64_t tick) const
+    {
+        auto it = level_qty_.find(tick);
+        return it == level_qty_.end() ? 0 : clamp(it->second);
+    }
+
+    // Walk away from the touch (up the asks, down the bids) until `qty` is filled.
+    std::optional<WalkResult> walk(uint64_t qty) const
+    {
+        if (qty == 0 || total_.qty == 0)
+        {
+            return std::nullopt;
+        }
+        if (qty >= total_.qty)
+        {
+            // total_.qty fits in uint64_t here
+            uint64_t worst = side_ == Side::Sell ? largest_prefix_at_most(total_.qty - 1) : largest_prefix_at_most(0);
+            return WalkResult{clamp(total_.qty), total_.notional, worst, total_.levels};
+        }
+        if (side_ == Side::Sell)
+        {
+            // ticks [0, k) hold less than qty, so tick k is the worst level touched
+            uint64_t k = largest_prefix_at_most(qty - 1);
+            Node below = prefix(k);
+            return WalkResult{qty, below.notional + (qty - below.qty) * k, k, prefix(k + 1).levels};
+        }
+        // ticks above k hold less than qty, so tick k is the worst level touched
+        uint64_t k = largest_prefix_at_most(total_.qty - qty);
+        Node through = prefix(k + 1);
+        LadderSum above = total_.qty - through.qty;
+        LadderSum notional = total_.notional - through.notional + (qty - above) * k;
+        return WalkResult{qty, notional, k, total_.levels - prefix(k).levels};
+    }
+
+private:
+    struct Node
+    {
+        LadderSum qty = 0;
+        LadderSum notional = 0; // qty * tick
+        uint64_t levels = 0;    // number of non-empty ticks
+    };
+
+    static uint64_t clamp(LadderSum v)
+    {
+        return v > UINT64_MAX ? UINT64_MAX : static_cast<uint64_t>(v);
+    }
+
+    // Sums over ticks [0, n).
+    Node prefix(uint64_t n) const
+    {
+        Node sum;
+        for (uint64_t i = n; i > 0; i -= i & (~i + 1))
+        {
+            auto it = nodes_.find(i);
+            if (it != nodes_.end())
+            {
+                sum.qty += it->second.qty;
+                sum.notional += it->second.notional;
+                sum.levels += it->second.levels;
+            }
+        }
+        return sum;
+    }
+
+    // Largest n such that the quantity in ticks [0, n) is <= target.
+    uint64_t largest_prefix_at_most(LadderSum target) const
+    {
+        uint64_t pos = 0;
+        for (uint64_t step = kLadderSize; step > 0; step /= 2)
+        {
+            auto it = nodes_.find(pos + step);
+            LadderSum q = it == nodes_.end() ? 0 : it->second.qty;
+            if (q <= target)
+            {
+                pos += step;
+                target -= q;
+            }
+        }
+        return pos;
+    }
+
+    Side side_;
+    std::unordered_map<uint64_t, Node> nodes_;           // Fenwick node index (1-based) -> sums
+    std::unordered_map<uint64_t, LadderSum> level_qty_; // tick -> resting qty
+    Node total_;
+};
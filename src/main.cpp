@@ -2,6 +2,7 @@
 #include "csv_logger.hpp"
 // #include "tcp_server.hpp"   // <-- you'll include this once you create tcp_server.cpp
 
+#include <utility> // std::exchange, used by boost/asio/awaitable.hpp without including it
 #include <boost/asio.hpp>
 #include <memory>
 #include <thread>
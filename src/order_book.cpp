@@ -2,6 +2,7 @@
 #include "order_book.hpp"
 #include <sstream>
 #include <chrono>
+#include <stdexcept>
 #include "types.hpp"
 
 OrderBook::OrderBook(CSVLogger &logger)
@@ -19,7 +20,18 @@ void OrderBook::record_trade(const Trade &t)
 // ------------------------------------------------------------
 std::vector<Trade> OrderBook::place_order(Order ord)
 {
+    auto tick = price_to_ticks(ord.price);
+    if (!tick.has_value())
+    {
+        throw std::invalid_argument("Order price is not on the tick ladder");
+    }
+    // book keys must be canonical, prices within the tolerance share one level
+    ord.price = ticks_to_price(tick.value());
     std::lock_guard<std::mutex> lock(mu_);
+    if (const char *reason = risk_.check(ord))
+    {
+        throw RiskRejected(reason);
+    }
     OrderId order_id = next_order_id_.fetch_add(1);
     ord.id = order_id;
     ord.ts = std::chrono::system_clock::now();
@@ -40,6 +52,9 @@ std::vector<Trade> OrderBook::place_order(Order ord)
         queue.push_back(ord);
         auto it = std::prev(queue.end());
         order_index_[order_id] = OrderRef{ord.side, ord.price, it};
+        LevelIndex &levels = ord.side == Side::Buy ? bid_levels_ : ask_levels_;
+        levels.add(tick.value(), ord.qty);
+        risk_.on_rest(ord);
     }
 
     return fulfilled_trades;
@@ -53,36 +68,41 @@ std::vector<Trade> OrderBook::match_buy(Order &incoming)
     std::vector<Trade> trades;
     while (incoming.qty > 0)
     {
-        auto best_ask_price = best_ask();
-        if (!best_ask_price.has_value())
+        // read asks_ directly, best_ask() locks mu_ which place_order already holds
+        if (asks_.empty())
         { // no liquidity
             break;
         }
-        if (incoming.price < best_ask_price.value())
+        auto level = asks_.begin();
+        double best_ask_price = level->first;
+        if (incoming.price < best_ask_price)
         { // price cannot match
             break;
         }
 
         // there is a match, fill all orders in book
-        auto &queue = asks_[best_ask_price.value()];
+        auto &queue = level->second;
+        uint64_t tick = price_to_ticks(best_ask_price).value();
         while (!queue.empty() && incoming.qty > 0)
         { // match the current order with the best price orders
             Order &ask_order = queue.front();
             uint64_t fulfilled_qty = std::min(incoming.qty, ask_order.qty);
             ask_order.qty -= fulfilled_qty;
             incoming.qty -= fulfilled_qty;
-            Trade trade{incoming.id, ask_order.id, best_ask_price.value(), fulfilled_qty, std::chrono::system_clock::now()};
+            ask_levels_.add(tick, -static_cast<int64_t>(fulfilled_qty));
+            risk_.on_fill(incoming, ask_order, fulfilled_qty);
+            Trade trade{incoming.id, ask_order.id, best_ask_price, fulfilled_qty, std::chrono::system_clock::now()};
             trades.push_back(trade);
             record_trade(trade);
             if (ask_order.qty == 0)
-            { // filled already
-                queue.pop_front();
+            { // filled already, drop the index entry before the order itself
                 order_index_.erase(ask_order.id);
+                queue.pop_front();
             }
         }
         if (queue.empty())
         {
-            asks_.erase(best_ask_price.value());
+            asks_.erase(level);
         }
     }
 
@@ -102,36 +122,41 @@ std::vector<Trade> OrderBook::match_sell(Order &incoming)
     std::vector<Trade> trades;
     while (incoming.qty > 0)
     {
-        auto best_bid_price = best_bid();
-        if (!best_bid_price.has_value())
+        // read bids_ directly, best_bid() locks mu_ which place_order already holds
+        if (bids_.empty())
         { // no liquidity
             break;
         }
-        if (incoming.price > best_bid_price.value())
+        auto level = std::prev(bids_.end());
+        double best_bid_price = level->first;
+        if (incoming.price > best_bid_price)
         { // price cannot match
             break;
         }
 
         // there is a match, fill all orders in book
-        auto &queue = bids_[best_bid_price.value()];
+        auto &queue = level->second;
+        uint64_t tick = price_to_ticks(best_bid_price).value();
         while (!queue.empty() && incoming.qty > 0)
         { // match the current order with the best price orders
             Order &bid_order = queue.front();
             uint64_t fulfilled_qty = std::min(incoming.qty, bid_order.qty);
             bid_order.qty -= fulfilled_qty;
             incoming.qty -= fulfilled_qty;
-            Trade trade{bid_order.id, incoming.id, best_bid_price.value(), fulfilled_qty, std::chrono::system_clock::now()};
+            bid_levels_.add(tick, -static_cast<int64_t>(fulfilled_qty));
+            risk_.on_fill(incoming, bid_order, fulfilled_qty);
+            Trade trade{bid_order.id, incoming.id, best_bid_price, fulfilled_qty, std::chrono::system_clock::now()};
             trades.push_back(trade);
             record_trade(trade);
             if (bid_order.qty == 0)
-            { // filled already
-                queue.pop_front();
+            { // filled already, drop the index entry before the order itself
                 order_index_.erase(bid_order.id);
+                queue.pop_front();
             }
         }
         if (queue.empty())
         {
-            bids_.erase(best_bid_price.value());
+            bids_.erase(level);
         }
     }
 
@@ -158,6 +183,8 @@ bool OrderBook::cancel_order(OrderId id)
             return false;
         }
         auto &queue = map_it->second;
+        bid_levels_.add(price_to_ticks(order_ref.price).value(), -static_cast<int64_t>(order_ref.it->qty));
+        risk_.on_cancel(*order_ref.it);
         queue.erase(order_ref.it);
         if (queue.empty())
         {
@@ -172,6 +199,8 @@ bool OrderBook::cancel_order(OrderId id)
             return false;
         }
         auto &queue = map_it->second;
+        ask_levels_.add(price_to_ticks(order_ref.price).value(), -static_cast<int64_t>(order_ref.it->qty));
+        risk_.on_cancel(*order_ref.it);
         queue.erase(order_ref.it);
         if (queue.empty())
         {
@@ -195,12 +224,7 @@ std::string OrderBook::snapshot_top(size_t depth) const
     for (auto it = bids_.rbegin(); it != bids_.rend() && count < depth; it++, count++)
     {
         double price = it->first;
-        const auto &queue = it->second;
-        uint64_t qty = 0;
-        for (const auto &order : queue)
-        {
-            qty += order.qty;
-        }
+        uint64_t qty = bid_levels_.level_qty(price_to_ticks(price).value());
         if (count > 0)
         {
             ss << ", ";
@@ -212,11 +236,7 @@ std::string OrderBook::snapshot_top(size_t depth) const
     for (auto it = asks_.begin(); it != asks_.end() && count < depth; ++it, ++count)
     {
         double price = it->first;
-        const auto &queue = it->second;
-
-        uint64_t qty = 0;
-        for (const auto &o : queue)
-            qty += o.qty;
+        uint64_t qty = ask_levels_.level_qty(price_to_ticks(price).value());
 
         if (count > 0)
             ss << ", ";
@@ -253,3 +273,27 @@ std::optional<double> OrderBook::best_ask() const
     }
     return std::nullopt;
 }
+
+// ------------------------------------------------------------
+// quote, cost of taking qty from the opposite side of the book
+// ------------------------------------------------------------
+std::optional<Quote> OrderBook::quote(Side side, uint64_t qty) const
+{
+    std::lock_guard<std::mutex> lock(mu_);
+    auto walk = side == Side::Buy ? ask_levels_.walk(qty) : bid_levels_.walk(qty);
+    if (!walk.has_value())
+    {
+        return std::nullopt;
+    }
+    double avg_price = static_cast<double>(walk->notional) / static_cast<double>(walk->qty) / kTicksPerUnit;
+    return Quote{walk->qty, avg_price, ticks_to_price(walk->worst_tick), walk->levels};
+}
+
+// ------------------------------------------------------------
+// set_risk_limits
+// ------------------------------------------------------------
+void OrderBook::set_risk_limits(RiskLimitTable table)
+{
+    std::lock_guard<std::mutex> lock(mu_);
+    risk_.set_limits(std::move(table));
+}
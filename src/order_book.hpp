@@ -6,9 +6,13 @@
 #include <mutex>
 #include <vector>
 #include <string>
+#include <optional>
+#include <atomic>
 
 #include "types.hpp"
 #include "csv_logger.hpp"
+#include "level_index.hpp"
+#include "pre_trade_risk.hpp"
 #include <list>
 
 class OrderBook
@@ -20,6 +24,7 @@ public:
 
     // Place an order into the book. The order may execute immediately (partial/full)
     // against resting orders on the opposite side. Returns the list of executed trades.
+    // Throws RiskRejected if the order breaches its client's pre-trade limits.
     std::vector<Trade> place_order(Order ord);
 
     // Cancel an existing order by id. Returns true if the order was found and removed.
@@ -32,6 +37,14 @@ public:
     std::optional<double> best_bid() const;
     std::optional<double> best_ask() const;
 
+    // Cost of taking `qty` from the book right now without trading: a buy walks the asks,
+    // a sell walks the bids. O(log of the tick range). Returns std::nullopt if that side is empty.
+    std::optional<Quote> quote(Side side, uint64_t qty) const;
+
+    // Replace the pre-trade risk limits. Safe to call while orders are flowing;
+    // client exposure is kept.
+    void set_risk_limits(RiskLimitTable table);
+
 private:
     // Helper matching functions (internal). They mutate the incoming Order and
     // generate trades which are returned to the caller.
@@ -48,6 +61,13 @@ private:
     // order_id -> (price, side)
     std::unordered_map<OrderId, OrderRef> order_index_;
 
+    // cumulative quantity / notional per price tick, kept in step with bids_ and asks_
+    LevelIndex bid_levels_{Side::Buy};
+    LevelIndex ask_levels_{Side::Sell};
+
+    // per-client limits and exposure, checked before matching
+    PreTradeRisk risk_;
+
     // mutex protecting all mutable state above
     mutable std::mutex mu_;
 
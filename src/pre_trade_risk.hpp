@@ -0,0 +1,219 @@
+#pragma once
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include "types.hpp"
+
+// Per-client limits. Defaults are unlimited.
+struct RiskLimits
+{
+    uint64_t max_order_qty = std::numeric_limits<uint64_t>::max();
+    double max_notional = std::numeric_limits<double>::infinity(); // price * qty of a single order
+    uint64_t max_open_orders = std::numeric_limits<uint64_t>::max();
+    int64_t max_position = std::numeric_limits<int64_t>::max(); // absolute net position, counting open orders
+};
+
+struct RiskLimitTable
+{
+    RiskLimits defaults;                              // for clients without their own entry
+    std::unordered_map<ClientId, RiskLimits> clients;
+};
+
+// Thrown by OrderBook::place_order when an order breaches its client's limits.
+class RiskRejected : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Parse one non-negative limit field, ignoring surrounding blanks. The whole
+// field must be consumed. Returns false on anything else.
+template <typename T>
+bool parse_risk_field(std::string_view field, T &out)
+{
+    size_t begin = field.find_first_not_of(" \t\r");
+    size_t end = field.find_last_not_of(" \t\r");
+    if (begin == std::string_view::npos)
+    {
+        return false;
+    }
+    field = field.substr(begin, end - begin + 1);
+    auto res = std::from_chars(field.data(), field.data() + field.size(), out);
+    if (res.ec != std::errc() || res.ptr != field.data() + field.size())
+    {
+        return false;
+    }
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        return !std::isnan(out) && out >= 0;
+    }
+    else if constexpr (std::is_signed_v<T>)
+    {
+        return out >= 0;
+    }
+    else
+    {
+        return true; // from_chars already rejects a leading '-' for unsigned types
+    }
+}
+
+// Load limits from a CSV file, one line per client:
+//   client,max_order_qty,max_notional,max_open_orders,max_position
+// A client of "*" sets the defaults. Empty lines and lines starting with '#' are skipped.
+// All limits must be non-negative numbers; max_notional may be "inf".
+// Throws std::runtime_error naming the offending line on any malformed entry.
+inline RiskLimitTable load_risk_limits(const std::string &filename)
+{
+    std::ifstream ifs(filename);
+    if (!ifs.is_open())
+    {
+        throw std::runtime_error("Unable to open risk limits file: " + filename);
+    }
+    RiskLimitTable table;
+    std::string line;
+    while (std::getline(ifs, line))
+    {
+        if (line.empty() || line[0] == '#' || line.find_first_not_of(" \t\r") == std::string::npos)
+        {
+            continue;
+        }
+        std::istringstream iss(line);
+        std::string client, max_qty, max_notional, max_open, max_position;
+        RiskLimits limits;
+        if (!std::getline(iss, client, ',') || !std::getline(iss, max_qty, ',') ||
+            !std::getline(iss, max_notional, ',') || !std::getline(iss, max_open, ',') ||
+            !std::getline(iss, max_position) ||
+            !parse_risk_field(max_qty, limits.max_order_qty) ||
+            !parse_risk_field(max_notional, limits.max_notional) ||
+            !parse_risk_field(max_open, limits.max_open_orders) ||
+            !parse_risk_field(max_position, limits.max_position))
+        {
+            throw std::runtime_error("Invalid risk limits line: " + line);
+        }
+        size_t begin = client.find_first_not_of(" \t");
+        if (begin == std::string::npos)
+        {
+            throw std::runtime_error("Invalid risk limits line: " + line);
+        }
+        client = client.substr(begin, client.find_last_not_of(" \t") - begin + 1);
+        if (client == "*")
+        {
+            table.defaults = limits;
+        }
+        else
+        {
+            table.clients[client] = limits;
+        }
+    }
+    return table;
+}
+
+// Inline pre-trade risk stage. Exposure is kept per client and updated from
+// rests, fills and cancels, so a check is a couple of hash lookups and integer
+// comparisons. Not thread safe, the owning OrderBook guards it with its mutex.
+class PreTradeRisk
+{
+public:
+    void set_limits(RiskLimitTable table)
+    {
+        table_ = std::move(table);
+    }
+
+    // Returns nullptr if the order may go to the book, otherwise the reason it may not.
+    const char *check(const Order &ord) const
+    {
+        const RiskLimits &limits = limits_for(ord.client);
+        // exposure and the level index count quantity in int64_t, larger orders are never valid
+        if (ord.qty > limits.max_order_qty || ord.qty > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+        {
+            return "max order qty";
+        }
+        if (ord.price * static_cast<double>(ord.qty) > limits.max_notional)
+        {
+            return "max notional";
+        }
+        auto it = exposure_.find(ord.client);
+        Exposure exp = it == exposure_.end() ? Exposure{} : it->second;
+        if (exp.open_orders >= limits.max_open_orders)
+        {
+            return "max open orders";
+        }
+        // worst case: every open order on the same side fills along with this one
+        int64_t qty = static_cast<int64_t>(ord.qty);
+        if (ord.side == Side::Buy
+                ? saturating_add(saturating_add(exp.position, exp.open_buy_qty), qty) > limits.max_position
+                : saturating_sub(saturating_sub(exp.position, exp.open_sell_qty), qty) < -limits.max_position)
+        {
+            return "max position";
+        }
+        return nullptr;
+    }
+
+    // The remainder of an incoming order rests on the book.
+    void on_rest(const Order &ord)
+    {
+        Exposure &exp = exposure_[ord.client];
+        ++exp.open_orders;
+        (ord.side == Side::Buy ? exp.open_buy_qty : exp.open_sell_qty) += static_cast<int64_t>(ord.qty);
+    }
+
+    // An incoming order traded qty against a resting order.
+    void on_fill(const Order &incoming, const Order &resting, uint64_t qty)
+    {
+        int64_t signed_qty = incoming.side == Side::Buy ? static_cast<int64_t>(qty) : -static_cast<int64_t>(qty);
+        exposure_[incoming.client].position += signed_qty;
+
+        Exposure &exp = exposure_[resting.client];
+        exp.position -= signed_qty;
+        (resting.side == Side::Buy ? exp.open_buy_qty : exp.open_sell_qty) -= static_cast<int64_t>(qty);
+        if (resting.qty == 0)
+        {
+            --exp.open_orders;
+        }
+    }
+
+    // A resting order was cancelled with ord.qty still open.
+    void on_cancel(const Order &ord)
+    {
+        Exposure &exp = exposure_[ord.client];
+        --exp.open_orders;
+        (ord.side == Side::Buy ? exp.open_buy_qty : exp.open_sell_qty) -= static_cast<int64_t>(ord.qty);
+    }
+
+private:
+    struct Exposure
+    {
+        int64_t position = 0; // net filled qty, positive is long
+        uint64_t open_orders = 0;
+        int64_t open_buy_qty = 0;
+        int64_t open_sell_qty = 0;
+    };
+
+    // a + b and a - b for b >= 0, clamped to the int64_t range instead of overflowing
+    static int64_t saturating_add(int64_t a, int64_t b)
+    {
+        return a > std::numeric_limits<int64_t>::max() - b ? std::numeric_limits<int64_t>::max() : a + b;
+    }
+
+    static int64_t saturating_sub(int64_t a, int64_t b)
+    {
+        return a < std::numeric_limits<int64_t>::min() + b ? std::numeric_limits<int64_t>::min() : a - b;
+    }
+
+    const RiskLimits &limits_for(const ClientId &client) const
+    {
+        auto it = table_.clients.find(client);
+        return it == table_.clients.end() ? table_.defaults : it->second;
+    }
+
+    RiskLimitTable table_;
+    std::unordered_map<ClientId, Exposure> exposure_;
+};
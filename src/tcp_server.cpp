@@ -1,17 +1,21 @@
 // tcp_server.cpp
 #include "tcp_server.hpp"
+#include <boost/algorithm/string/predicate.hpp>
+#include <charconv>
 #include <iostream>
-#include <sstream>
+#include <type_traits>
 
 namespace net
 {
 
     TCPServer::TCPServer(boost::asio::io_context &ioc,
                          tcp::endpoint endpoint,
-                         OrderBook &book)
+                         OrderBook &book,
+                         AdmissionLimits limits)
         : ioc_(ioc),
           acceptor_(ioc, endpoint), // acceptor typically created using the io_context and tcp::endpoint
-          book_(book)
+          book_(book),
+          limits_(limits)
     {
         std::cout << "TCP server created" << std::endl;
     }
@@ -37,7 +41,7 @@ namespace net
             {
                 if (!ec)
                 {
-                    auto session = std::make_shared<Session>(std::move(socket), book_);
+                    auto session = std::make_shared<Session>(std::move(socket), *this);
                     session->start();
                 }
                 // Call do_accept again to continue listening for the next client
@@ -45,13 +49,139 @@ namespace net
             });
     }
 
+    // ------------------------------------------------------------
+    // Queue a session whose command was admitted
+    // ------------------------------------------------------------
+    void TCPServer::submit(Session *session)
+    {
+        std::lock_guard<std::mutex> lock(admission_mu_);
+        ready_.push_back(session);
+        if (!draining_)
+        {
+            draining_ = true;
+            ba::post(ioc_, [this]()
+                     { drain(); });
+        }
+    }
+
+    // ------------------------------------------------------------
+    // Run queued commands against the book, one session at a time
+    // ------------------------------------------------------------
+    void TCPServer::drain()
+    {
+        for (;;)
+        {
+            Session *session;
+            {
+                std::lock_guard<std::mutex> lock(admission_mu_);
+                if (ready_.empty())
+                {
+                    draining_ = false;
+                    return;
+                }
+                session = ready_.front();
+                ready_.pop_front();
+            }
+            // take_turn() reports command errors to its session; anything escaping it must
+            // not stop the drain, or draining_ stays set and no session is served again
+            try
+            {
+                session->take_turn();
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Admission error: " << e.what() << std::endl;
+            }
+        }
+    }
+
+    namespace
+    {
+        using boost::algorithm::iequals;
+
+        // STATS is answered by the session itself and never throttled
+        bool is_stats_command(std::string_view line)
+        {
+            size_t begin = line.find_first_not_of(" \t\r");
+            size_t end = line.find_last_not_of(" \t\r");
+            return begin != std::string_view::npos && iequals(line.substr(begin, end - begin + 1), "STATS");
+        }
+
+        template <typename T>
+        bool parse_number(std::string_view s, T &out)
+        {
+            auto res = std::from_chars(s.data(), s.data() + s.size(), out);
+            return res.ec == std::errc() && res.ptr == s.data() + s.size();
+        }
+
+        template <typename T>
+        void append_number(std::string &out, T value)
+        {
+            char buf[32];
+            std::to_chars_result res;
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                // same output as the default ostream formatting (%g, 6 digits)
+                res = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::general, 6);
+            }
+            else
+            {
+                res = std::to_chars(buf, buf + sizeof(buf), value);
+            }
+            out.append(buf, res.ptr);
+        }
+
+        // A price on the tick ladder, always with two decimals.
+        void append_price(std::string &out, double price)
+        {
+            char buf[32];
+            auto res = std::to_chars(buf, buf + sizeof(buf), price, std::chars_format::fixed, 2);
+            out.append(buf, res.ptr);
+        }
+
+        // Shortest form that parses back to exactly `value`.
+        void append_round_trip(std::string &out, double value)
+        {
+            char buf[32];
+            auto res = std::to_chars(buf, buf + sizeof(buf), value);
+            out.append(buf, res.ptr);
+        }
+
+        void append_trades(std::string &out, const std::vector<Trade> &trades)
+        {
+            out += "--- Trade List ---\n";
+            for (size_t i = 0; i < trades.size(); ++i)
+            {
+                const auto &trade = trades[i];
+                auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(trade.ts.time_since_epoch()).count();
+
+                out += "Trade ";
+                append_number(out, i + 1);
+                out += ":\n  BuyOrder: ";
+                append_number(out, trade.buy_order);
+                out += "\n  SellOrder: ";
+                append_number(out, trade.sell_order);
+                out += "\n  Price: $";
+                append_number(out, trade.price);
+                out += "\n  Quantity: ";
+                append_number(out, trade.qty);
+                out += "\n  Timestamp: ";
+                append_number(out, ms);
+                out += "\n";
+            }
+            out += "--- End of List ---\n";
+        }
+    }
+
     // ======================================================================
     // ============================= SESSION =================================
     // ======================================================================
 
-    TCPServer::Session::Session(tcp::socket socket, OrderBook &book)
+    TCPServer::Session::Session(tcp::socket socket, TCPServer &server)
         : socket_(std::move(socket)),
-          book_(book)
+          server_(server),
+          book_(server.book_),
+          bucket_(server.limits_)
     {
     }
 
@@ -60,85 +190,145 @@ namespace net
     // ------------------------------------------------------------
     void TCPServer::Session::start()
     {
-        do_read();
         std::cout << "Client connected from: "
                   << socket_.remote_endpoint().address().to_string()
                   << ":" << socket_.remote_endpoint().port() << std::endl;
+        // The lambda (and the self reference it holds) lives in the spawned coroutine
+        // frame, so the Session is kept alive for the whole loop with a single refcount bump.
+        ba::co_spawn(
+            socket_.get_executor(),
+            [self = shared_from_this()]() -> ba::awaitable<void>
+            { co_await self->run(); },
+            ba::detached);
     }
 
     // ------------------------------------------------------------
-    // Set up async read until newline
+    // Read a line, handle it, write the response, repeat
     // ------------------------------------------------------------
-    void TCPServer::Session::do_read()
+    ba::awaitable<void> TCPServer::Session::run()
     {
-        // Capturing self ensures the Session stays alive until handler completes
-        async_read_until(socket_, buffer_, "\n",
-                         [this, self = shared_from_this()](boost::system::error_code ec, size_t n)
-                         {
-                             on_read(ec, n);
-                         });
+        try
+        {
+            for (;;)
+            {
+                std::size_t n = co_await ba::async_read_until(socket_, buffer_, '\n', ba::use_awaitable);
+                // streambuf storage is contiguous, so the line can be viewed in place
+                auto data = buffer_.data();
+                std::string_view line(static_cast<const char *>(data.data()), n - 1);
+
+                out_.clear();
+                ++stats_.received;
+                if (is_stats_command(line))
+                {
+                    process_line(line);
+                }
+                else if (!bucket_.try_acquire())
+                {
+                    ++stats_.throttled;
+                    write_response("THROTTLED\n");
+                }
+                else
+                {
+                    ++stats_.admitted;
+                    pending_line_ = line;
+                    // suspend until the server reaches us in its ready queue; take_turn() fills out_
+                    co_await ba::async_initiate<const ba::use_awaitable_t<> &, void(std::exception_ptr)>(
+                        [this](TurnHandler handler)
+                        {
+                            turn_.emplace(std::move(handler));
+                            server_.submit(this);
+                        },
+                        ba::use_awaitable);
+                }
+                buffer_.consume(n);
+
+                if (!out_.empty())
+                {
+                    co_await ba::async_write(socket_, ba::buffer(out_), ba::use_awaitable);
+                }
+            }
+        }
+        catch (const boost::system::system_error &e)
+        {
+            if (e.code() != ba::error::eof)
+            {
+                std::cerr << "Session error: " << e.what() << std::endl;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Session error: " << e.what() << std::endl;
+        }
+        boost::system::error_code ignored;
+        socket_.close(ignored);
     }
 
     // ------------------------------------------------------------
-    // Handle a full incoming line
+    // Process the pending command and resume the session coroutine
     // ------------------------------------------------------------
-    void TCPServer::Session::on_read(boost::system::error_code ec,
-                                     std::size_t bytes_transferred)
+    void TCPServer::Session::take_turn()
     {
-        if (ec)
+        // a failing command is handed back to the session coroutine instead of
+        // escaping into drain(); the session is always resumed
+        std::exception_ptr error;
+        try
         {
-            if (ec == boost::asio::error::eof)
-            {
-                if (socket_.is_open())
-                    socket_.close();
-            }
-            else
-            {
-                std::cerr << "Read error: " << ec.message() << std::endl;
-            }
-            return;
+            process_line(pending_line_);
         }
-        std::istream is(&buffer_);
-        std::string line;
-        std::getline(is, line);
-        process_line(line);
-        do_read();
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        TurnHandler handler = std::move(*turn_);
+        turn_.reset();
+        auto ex = handler.get_executor();
+        ba::post(ex, [handler = std::move(handler), error]() mutable
+                 { handler(error); });
     }
 
     // ------------------------------------------------------------
     // Parse commands and call OrderBook
     // ------------------------------------------------------------
-    void TCPServer::Session::process_line(const std::string &line)
+    void TCPServer::Session::process_line(std::string_view line)
     {
-        std::vector<std::string> tokens;
-        std::istringstream iss(line);
-        std::string token;
-        while (iss >> token)
+        // split on whitespace; the views point into buffer_ which is consumed after this returns
+        tokens_.clear();
+        size_t pos = 0;
+        while (pos < line.size())
         {
-            tokens.push_back(token);
+            pos = line.find_first_not_of(" \t\r", pos);
+            if (pos == std::string_view::npos)
+            {
+                break;
+            }
+            size_t end = line.find_first_of(" \t\r", pos);
+            if (end == std::string_view::npos)
+            {
+                end = line.size();
+            }
+            tokens_.push_back(line.substr(pos, end - pos));
+            pos = end;
         }
-        if (tokens.empty())
+        if (tokens_.empty())
         {
             write_response("ERROR empty command\n");
+            return;
         }
-        std::string command = tokens.at(0);
-        std::transform(command.begin(), command.end(), command.begin(), ::toupper);
+        std::string_view command = tokens_[0];
 
-        if (command == "ORDER")
+        if (iequals(command, "ORDER"))
         {
-            if (tokens.size() != 5)
+            if (tokens_.size() != 5)
             {
                 write_response("ERROR Invalid ORDER arguments\n");
                 return;
             }
-            std::string token_str = tokens.at(1);
-            std::transform(token_str.begin(), token_str.end(), token_str.begin(), ::tolower);
             Side side;
-            if (token_str == "buy")
+            if (iequals(tokens_[1], "buy"))
             {
                 side = Side::Buy;
             }
-            else if (token_str == "sell")
+            else if (iequals(tokens_[1], "sell"))
             {
                 side = Side::Sell;
             }
@@ -147,40 +337,106 @@ namespace net
                 write_response("ERROR Invalid side provided for ORDER command\n");
                 return;
             }
-            double price = stod(tokens.at(2));
-            uint64_t qty = stoull(tokens.at(3));
-            if (price < 0 || qty == 0)
+            double price = 0;
+            uint64_t qty = 0;
+            if (!parse_number(tokens_[2], price) || !parse_number(tokens_[3], qty) || price < 0 || qty == 0)
             {
                 write_response("ERROR Invalid price or quantity provided for ORDER command\n");
                 return;
             }
-            ClientId clientId = tokens.at(4);
+            if (!price_to_ticks(price).has_value())
+            {
+                write_response("ERROR Price is not a multiple of the tick size\n");
+                return;
+            }
+            ClientId clientId(tokens_[4]);
             Order ord(-1, clientId, side, price, qty, qty, std::chrono::system_clock::now());
-            auto trades = book_.place_order(ord);
-            std::string trade_response = formatTrades(trades);
-            write_response(trade_response);
+            try
+            {
+                auto trades = book_.place_order(ord);
+                append_trades(out_, trades);
+            }
+            catch (const RiskRejected &e)
+            {
+                out_ += "REJECTED ";
+                out_ += e.what();
+                out_ += '\n';
+            }
         }
-        else if (command == "CANCEL")
+        else if (iequals(command, "CANCEL"))
         {
-            if (tokens.size() != 2)
+            OrderId orderId = 0;
+            if (tokens_.size() != 2 || !parse_number(tokens_[1], orderId))
             {
                 write_response("ERROR invalid CANCEL arguments\n");
                 return;
             }
-            OrderId orderId = stoull(tokens.at(1));
             bool ok = book_.cancel_order(orderId);
             write_response(ok ? "CANCELLED\n" : "NOT_FOUND\n");
         }
-        else if (command == "SNAPSHOT")
+        else if (iequals(command, "SNAPSHOT"))
         {
-            if (tokens.size() != 2)
+            size_t depth = 0;
+            if (tokens_.size() != 2 || !parse_number(tokens_[1], depth))
             {
                 write_response("ERROR invalid SNAPSHOT arguments\n");
                 return;
             }
-            size_t depth = stoull(tokens.at(1));
-            auto json = book_.snapshot_top(depth);
-            write_response(json + "\n");
+            out_ += book_.snapshot_top(depth);
+            out_ += '\n';
+        }
+        else if (iequals(command, "QUOTE"))
+        {
+            if (tokens_.size() != 3)
+            {
+                write_response("ERROR invalid QUOTE arguments\n");
+                return;
+            }
+            Side side;
+            if (iequals(tokens_[1], "buy"))
+            {
+                side = Side::Buy;
+            }
+            else if (iequals(tokens_[1], "sell"))
+            {
+                side = Side::Sell;
+            }
+            else
+            {
+                write_response("ERROR Invalid side provided for QUOTE command\n");
+                return;
+            }
+            uint64_t qty = 0;
+            if (!parse_number(tokens_[2], qty) || qty == 0)
+            {
+                write_response("ERROR Invalid quantity provided for QUOTE command\n");
+                return;
+            }
+            auto quote = book_.quote(side, qty);
+            if (!quote.has_value())
+            {
+                write_response("NO_LIQUIDITY\n");
+                return;
+            }
+            out_ += "QUOTE ";
+            append_number(out_, quote->qty);
+            out_ += ' ';
+            append_round_trip(out_, quote->avg_price);
+            out_ += ' ';
+            append_price(out_, quote->worst_price);
+            out_ += ' ';
+            append_number(out_, quote->levels);
+            out_ += '\n';
+        }
+        else if (iequals(command, "STATS"))
+        {
+            out_ += "STATS ";
+            append_number(out_, stats_.received);
+            out_ += ' ';
+            append_number(out_, stats_.admitted);
+            out_ += ' ';
+            append_number(out_, stats_.throttled);
+            out_ += '\n';
         }
         else
         {
@@ -189,41 +445,12 @@ namespace net
         }
     }
 
-    std::string formatTrades(const std::vector<Trade> &trades)
-    {
-        std::ostringstream oss;
-
-        oss << "--- Trade List ---\n";
-        for (size_t i = 0; i < trades.size(); ++i)
-        {
-            const auto &trade = trades[i];
-            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(trade.ts.time_since_epoch()).count();
-
-            oss << "Trade " << i + 1 << ":\n";
-            oss << "  BuyOrder: " << trade.buy_order << "\n";
-            oss << "  SellOrder: " << trade.sell_order << "\n";
-            oss << "  Price: $" << trade.price << "\n";
-            oss << "  Quantity: " << trade.qty << "\n";
-            oss << "  Timestamp: " << ms << "\n";
-        }
-        oss << "--- End of List ---\n";
-        return oss.str();
-    }
-
     // ------------------------------------------------------------
-    // Send response back to client
+    // Queue a response; run() sends out_ once the line is handled
     // ------------------------------------------------------------
-    void TCPServer::Session::write_response(const std::string &resp)
+    void TCPServer::Session::write_response(std::string_view resp)
     {
-        auto out = std::make_shared<std::string>(resp);
-
-        boost::asio::async_write(socket_, boost::asio::buffer(*out), [this, self = shared_from_this()](boost::system::error_code ec, size_t n)
-                                 { 
-                                    if(ec) {
-                                        std::cerr << "Write error: " << ec.message() << std::endl;
-                                        boost::system::error_code ignored;
-                                        socket_.close(ignored);
-                                    } });
+        out_.append(resp);
     }
 
 }
@@ -1,13 +1,25 @@
 #pragma once
 
 // Protocol (text):
-//   ORDER <buy|sell> <price> <qty> <client>
+//   ORDER <buy|sell> <price> <qty> <client>   -> trade list | REJECTED <reason> (pre-trade risk)
 //   CANCEL <order_id>
 //   SNAPSHOT <depth>
+//   QUOTE <buy|sell> <qty>   -> QUOTE <qty> <avg_price> <worst_price> <levels> | NO_LIQUIDITY
+//                            avg_price is printed at full precision, worst_price with two decimals
+//   STATS                    -> STATS <received> <admitted> <throttled> for this session
+// Any command other than STATS may be answered with THROTTLED when the session is over its rate limit.
 
+#include <utility> // std::exchange, used by boost/asio/awaitable.hpp without including it
 #include <boost/asio.hpp>
+#include <deque>
+#include <exception>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
+#include "admission.hpp"
 #include "order_book.hpp"
 
 namespace net
@@ -18,7 +30,8 @@ namespace net
     class TCPServer : public std::enable_shared_from_this<TCPServer>
     {
     public:
-        TCPServer(ba::io_context &ioc, tcp::endpoint endpoint, OrderBook &book);
+        TCPServer(ba::io_context &ioc, tcp::endpoint endpoint, OrderBook &book,
+                  AdmissionLimits limits = AdmissionLimits{});
 
         // Start accepting connections
         void run();
@@ -29,23 +42,56 @@ namespace net
         // inner per-connection session
         struct Session : public std::enable_shared_from_this<Session>
         {
-            Session(tcp::socket socket, OrderBook &book);
+            Session(tcp::socket socket, TCPServer &server);
             void start();
 
+            // Called by the server when this session's admitted command is up:
+            // runs it against the book and resumes the session coroutine.
+            void take_turn();
+
         private:
-            void do_read();
-            void on_read(boost::system::error_code ec, std::size_t bytes_transferred);
-            void process_line(const std::string &line);
-            void write_response(const std::string &resp);
+            // completion handler of the coroutine suspended waiting for its turn; a non-null
+            // exception_ptr is rethrown in the coroutine, which then closes the session
+            using TurnHandler = ba::async_result<ba::use_awaitable_t<>, void(std::exception_ptr)>::handler_type;
+
+            // Coroutine driving the read -> process -> write loop for this connection.
+            // The input and output buffers are reused and Asio recycles the coroutine frame
+            // and operation memory through its per-thread cache. Handling a command still
+            // allocates (client id, trade list, snapshot string); this has not been measured.
+            ba::awaitable<void> run();
+            void process_line(std::string_view line);
+            void write_response(std::string_view resp);
 
             tcp::socket socket_;
             boost::asio::streambuf buffer_;
+            TCPServer &server_;
             OrderBook &book_;
+
+            TokenBucket bucket_;
+            SessionStats stats_;
+            std::string_view pending_line_; // admitted command waiting for its turn, points into buffer_
+            std::optional<TurnHandler> turn_;
+
+            // Reused across requests; clear() keeps the capacity.
+            std::string out_;
+            std::vector<std::string_view> tokens_;
         };
 
+        // Admission: every session has at most one command in flight, so draining the
+        // ready queue in FIFO order serves the sessions round robin, one command each.
+        // Queued sessions are raw pointers: the suspended coroutine frame, held by the
+        // session's turn_ handler, keeps the session alive until its turn comes.
+        void submit(Session *session);
+        void drain();
+
         boost::asio::io_context &ioc_;
         tcp::acceptor acceptor_; // listens for incoming TCP connection requests on a specific network port
         OrderBook &book_;
+        AdmissionLimits limits_;
+
+        std::mutex admission_mu_; // guards ready_ and draining_
+        std::deque<Session *> ready_;
+        bool draining_ = false;
     };
 
 } // namespace net
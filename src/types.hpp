@@ -33,6 +33,14 @@ struct Trade
     std::chrono::system_clock::time_point ts;
 };
 
+struct Quote
+{
+    uint64_t qty;       // quantity available (less than requested if the book is too thin)
+    double avg_price;
+    double worst_price;
+    uint64_t levels;    // price levels consumed
+};
+
 struct OrderRef
 {
     Side side;
@@ -0,0 +1,191 @@
+// Randomized check of LevelIndex against a brute-force walk over a std::map.
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <map>
+#include <random>
+#include "level_index.hpp"
+
+#define CHECK(cond)                                                                  \
+    do                                                                               \
+    {                                                                                \
+        if (!(cond))                                                                 \
+        {                                                                            \
+            std::fprintf(stderr, "%s:%d: CHECK(%s)\n", __FILE__, __LINE__, #cond); \
+            ++failures;                                                              \
+        }                                                                            \
+    } while (0)
+
+namespace
+{
+    int failures = 0;
+
+    struct Expected
+    {
+        uint64_t qty = 0;
+        LadderSum notional = 0;
+        uint64_t worst_tick = 0;
+        uint64_t levels = 0;
+    };
+
+    // Fill `qty` level by level from the touch: up the asks, down the bids.
+    Expected brute_force_walk(Side side, const std::map<uint64_t, uint64_t> &book, uint64_t qty)
+    {
+        Expected exp;
+        auto take = [&](uint64_t tick, uint64_t level_qty)
+        {
+            if (exp.qty == qty)
+            {
+                return;
+            }
+            uint64_t fill = std::min(qty - exp.qty, level_qty);
+            exp.qty += fill;
+            exp.notional += static_cast<LadderSum>(fill) * tick;
+            exp.worst_tick = tick;
+            ++exp.levels;
+        };
+        if (side == Side::Sell)
+        {
+            for (auto it = book.begin(); it != book.end(); ++it)
+            {
+                take(it->first, it->second);
+            }
+        }
+        else
+        {
+            for (auto it = book.rbegin(); it != book.rend(); ++it)
+            {
+                take(it->first, it->second);
+            }
+        }
+        return exp;
+    }
+
+    void check_walk(Side side, const LevelIndex &index, const std::map<uint64_t, uint64_t> &book, uint64_t qty)
+    {
+        auto walk = index.walk(qty);
+        if (book.empty())
+        {
+            CHECK(!walk.has_value());
+            return;
+        }
+        Expected exp = brute_force_walk(side, book, qty);
+        CHECK(walk.has_value());
+        if (walk.has_value())
+        {
+            CHECK(walk->qty == exp.qty);
+            CHECK(walk->notional == exp.notional);
+            CHECK(walk->worst_tick == exp.worst_tick);
+            CHECK(walk->levels == exp.levels);
+        }
+    }
+
+    // Random adds, partial removals and touch fills. The touch jumps across the
+    // whole ladder every few hundred steps, and some orders rest far from it.
+    void random_book(Side side, uint64_t seed)
+    {
+        LevelIndex index(side);
+        std::map<uint64_t, uint64_t> book;
+        std::mt19937_64 rng(seed);
+        uint64_t center = kMaxPriceTicks / 2;
+
+        for (int step = 0; step < 8000; ++step)
+        {
+            if (step % 500 == 0)
+            {
+                center = rng() % kMaxPriceTicks;
+            }
+            uint64_t spread = rng() % 8 == 0 ? kMaxPriceTicks / 2 : 20000;
+            uint64_t tick = (center + kMaxPriceTicks + rng() % (2 * spread) - spread) % kMaxPriceTicks;
+            if (!book.empty() && rng() % 2 == 0)
+            {
+                tick = std::next(book.begin(), rng() % book.size())->first;
+            }
+
+            auto level = book.find(tick);
+            if (level == book.end() || rng() % 3 != 0)
+            {
+                uint64_t qty = rng() % 50 + 1;
+                book[tick] += qty;
+                index.add(tick, static_cast<int64_t>(qty));
+            }
+            else
+            {
+                uint64_t qty = rng() % level->second + 1;
+                index.add(tick, -static_cast<int64_t>(qty));
+                if ((level->second -= qty) == 0)
+                {
+                    book.erase(level);
+                }
+            }
+
+            if (!book.empty() && rng() % 4 == 0)
+            {
+                // a fill sweeps the whole touch level
+                auto touch = side == Side::Sell ? book.begin() : std::prev(book.end());
+                index.add(touch->first, -static_cast<int64_t>(touch->second));
+                book.erase(touch);
+            }
+
+            auto level_after = book.find(tick);
+            CHECK(index.level_qty(tick) == (level_after == book.end() ? 0 : level_after->second));
+
+            if (step % 5 == 0)
+            {
+                check_walk(side, index, book, rng() % 3000 + 1);
+                // past everything resting on the side
+                check_walk(side, index, book, rng() % 1000000 + 1000000);
+            }
+        }
+
+        // empty the side again
+        while (!book.empty())
+        {
+            auto it = book.begin();
+            index.add(it->first, -static_cast<int64_t>(it->second));
+            book.erase(it);
+        }
+        check_walk(side, index, book, 1);
+    }
+
+    // Orders of INT64_MAX at the top of the ladder overflow 64-bit sums.
+    void large_quantities(Side side)
+    {
+        const int64_t max_qty = INT64_MAX;
+        const uint64_t top = kMaxPriceTicks - 1;
+        LevelIndex index(side);
+        std::map<uint64_t, uint64_t> book;
+        index.add(top, max_qty);
+        index.add(top, max_qty);
+        index.add(100, max_qty);
+        book[top] = 2 * static_cast<uint64_t>(max_qty);
+        book[100] = static_cast<uint64_t>(max_qty);
+
+        CHECK(index.level_qty(top) == book[top]);
+        check_walk(side, index, book, static_cast<uint64_t>(max_qty) + 5);
+        check_walk(side, index, book, UINT64_MAX);
+
+        index.add(top, max_qty);
+        CHECK(index.level_qty(top) == UINT64_MAX);
+    }
+}
+
+int main()
+{
+    for (Side side : {Side::Buy, Side::Sell})
+    {
+        for (uint64_t seed = 1; seed <= 3; ++seed)
+        {
+            random_book(side, seed);
+        }
+        large_quantities(side);
+    }
+    if (failures != 0)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::puts("level_index_test: ok");
+    return 0;
+}